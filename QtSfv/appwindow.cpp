@@ -9,6 +9,7 @@ QtSfvWindow::QtSfvWindow()
 
 	QMenu* filemenu = menuBar()->addMenu("&File");
 	QAction* openaction = filemenu->addAction("Open");
+	QAction* copyaction = filemenu->addAction("Copy and verify...");
 		
 	QAction* closeaction = filemenu->addAction("Close");
 	filemenu->addSeparator();
@@ -24,9 +25,15 @@ QtSfvWindow::QtSfvWindow()
 	settingsdiag = new SettingsDialog(this);
 	ThreadCount = 5;
 	ChunkSize = MB(1);
+	AutoTune = false;
+	tuner = new AutoTuner(this);
+	report = nullptr;
+	RereadCopies = false;
+	ReportFormat = ReportWriter::Format::None;
 
 
 	connect(openaction, &QAction::triggered, this, &QtSfvWindow::OnActionOpen);
+	connect(copyaction, &QAction::triggered, this, &QtSfvWindow::OnActionCopy);
 	connect(closeaction, &QAction::triggered, this, &QtSfvWindow::OnActionClose);
 	connect(aboutaction, &QAction::triggered, this, [&] { QMessageBox
 		::information(this, "About", "This program written by FollowerOfBigboss", QMessageBox::StandardButton::Ok, QMessageBox::StandardButton::Ok);});
@@ -42,6 +49,15 @@ QtSfvWindow::QtSfvWindow()
 	connect(this, &QtSfvWindow::UpdateDialogChunkValue, settingsdiag, &SettingsDialog::OnUpdateChunkValue);
 	connect(settingsdiag, &SettingsDialog::UpdateChunkSize, this, &QtSfvWindow::OnUpdateChunkValue);
 
+	connect(this, &QtSfvWindow::UpdateDialogAutoTune, settingsdiag, &SettingsDialog::OnUpdateAutoTune);
+	connect(settingsdiag, &SettingsDialog::UpdateAutoTune, this, &QtSfvWindow::OnUpdateAutoTune);
+
+	connect(this, &QtSfvWindow::UpdateDialogReportFormat, settingsdiag, &SettingsDialog::OnUpdateReportFormat);
+	connect(settingsdiag, &SettingsDialog::UpdateReportFormat, this, &QtSfvWindow::OnUpdateReportFormat);
+
+	connect(this, &QtSfvWindow::UpdateDialogRereadCopies, settingsdiag, &SettingsDialog::OnUpdateRereadCopies);
+	connect(settingsdiag, &SettingsDialog::UpdateRereadCopies, this, &QtSfvWindow::OnUpdateRereadCopies);
+
 	treeWidget = new QTreeWidget(this);
 	treeWidget->setRootIsDecorated(false);
 	treeWidget->setAllColumnsShowFocus(true);
@@ -105,14 +121,27 @@ void QtSfvWindow::CreateAWorkerThread(uint32_t ThreadID, uint32_t beg, uint32_t
 	ThreadPool[ThreadID]->TID = ThreadID;
 	ThreadPool[ThreadID]->beg = beg;
 	ThreadPool[ThreadID]->ChunkSize = this->ChunkSize;
+	ThreadPool[ThreadID]->report = report;
+	ThreadPool[ThreadID]->SourceRoot = SfvPath;
+	ThreadPool[ThreadID]->DestRoot = DestPath;
+	ThreadPool[ThreadID]->RereadDest = RereadCopies;
 
-	for (int x = 0; x < partcount; x++)
+	if (AutoTune == true)
 	{
-		ThreadPool[ThreadID]->list.append(QDir::cleanPath(SfvPath + QDir::separator() + slookup[beg + x]));
+		ThreadPool[ThreadID]->tuner = tuner;
+	}
+	else
+	{
+		for (int x = 0; x < partcount; x++)
+		{
+			ThreadPool[ThreadID]->list.append(QDir::cleanPath(SfvPath + QDir::separator() + slookup[beg + x]));
+		}
 	}
 
 	connect(ThreadPool[ThreadID], &SfvThread::AcAppendCRC, this, &QtSfvWindow::OnAppendCrc);
 	connect(ThreadPool[ThreadID], &SfvThread::AcFileOpenFail, this, &QtSfvWindow::OnFileOpenFail);
+	connect(ThreadPool[ThreadID], &SfvThread::AcFileReadFail, this, &QtSfvWindow::OnFileReadFail);
+	connect(ThreadPool[ThreadID], &SfvThread::AcCopyFail, this, &QtSfvWindow::OnCopyFail);
 	connect(ThreadPool[ThreadID], &SfvThread::AcJobDone, this, &QtSfvWindow::OnThreadJobDone);
 
 	ThreadPool[ThreadID]->start();
@@ -127,6 +156,20 @@ void QtSfvWindow::ClearThreadPool()
 			delete ThreadPool[i];
 	}
 
+	// Results the old workers queued before they stopped would land on the next job's items and counters
+	QCoreApplication::removePostedEvents(this, QEvent::MetaCall);
+
+	tuner->Finish();
+
+	// Workers are gone, nothing can push anymore
+	if (report != nullptr)
+	{
+		report->Finish();
+		report->wait();
+		delete report;
+		report = nullptr;
+	}
+
 	for (int i = 0; i < items.size(); i++)
 	{
 		delete items[i];
@@ -142,6 +185,36 @@ void QtSfvWindow::ClearThreadPool()
 	ThreadPool.shrink_to_fit();
 }
 
+void QtSfvWindow::CreateReportWriter(const QString& sfvfile)
+{
+	if (ReportFormat == ReportWriter::Format::None)
+		return;
+
+	QFileInfo info(sfvfile);
+	QString ext = (ReportFormat == ReportWriter::Format::Csv) ? ".report.csv" : ".report.jsonl";
+	QString path = info.absolutePath() + QDir::separator() + info.completeBaseName() + ext;
+
+	report = new ReportWriter(ReportFormat);
+	report->copymode = !DestPath.isEmpty();
+	if (!report->Open(path))
+	{
+		QMessageBox::warning(this, "Warning", "Report file couldn't opened! Continuing without a report.");
+		delete report;
+		report = nullptr;
+		return;
+	}
+
+	report->names.reserve(FileCount);
+	report->expected.reserve(FileCount);
+	for (int i = 0; i < FileCount; i++)
+	{
+		report->names.append(slookup[i].toUtf8());
+		report->expected.push_back(QString(crclookup[i].c_str()).toUInt(0, 16));
+	}
+
+	report->start();
+}
+
 void QtSfvWindow::OnActionOpen()
 {
 	QString filename = QFileDialog::getOpenFileName(this, "Open Image", "", "SFV Files (*.sfv)");
@@ -150,7 +223,73 @@ void QtSfvWindow::OnActionOpen()
 		return;
 	}
 
+	DestPath.clear();
+	RunJob(filename);
+}
+
+void QtSfvWindow::OnActionCopy()
+{
+	QString filename = QFileDialog::getOpenFileName(this, "Open Image", "", "SFV Files (*.sfv)");
+	if (filename.isEmpty())
+	{
+		return;
+	}
+
+	QString dest = QFileDialog::getExistingDirectory(this, "Copy To");
+	if (dest.isEmpty())
+	{
+		return;
+	}
+
+	// Workers check every target against the real destination, so resolve symlinks once here
+	QString canonical = QFileInfo(dest).canonicalFilePath();
+	if (canonical.isEmpty() || canonical == QFileInfo(filename).absoluteDir().canonicalPath())
+	{
+		QMessageBox::critical(this, "Error", "Destination is the same as the source directory!");
+		return;
+	}
+
+	DestPath = canonical;
+	RunJob(filename);
+}
+
+bool QtSfvWindow::PrepareCopy(const QString& sfvfile)
+{
+	QString destsfv = QDir::cleanPath(DestPath + QDir::separator() + QFileInfo(sfvfile).fileName());
 
+	int existing = QFileInfo::exists(destsfv) ? 1 : 0;
+	for (int i = 0; i < FileCount; i++)
+	{
+		QString source = QDir::cleanPath(SfvPath + QDir::separator() + slookup[i]);
+		QString target = SfvThread::CopyTarget(SfvPath, DestPath, source);
+		if (!target.isEmpty() && QFileInfo::exists(target))
+			existing++;
+	}
+
+	// Archive storage, never overwrite anything without asking
+	if (existing != 0)
+	{
+		QMessageBox::StandardButton answer = QMessageBox::question(this, "Overwrite",
+			QString("%1 file(s) already exist in the destination and will be overwritten.\nContinue?").arg(existing),
+			QMessageBox::StandardButton::Yes | QMessageBox::StandardButton::No, QMessageBox::StandardButton::No);
+
+		if (answer != QMessageBox::StandardButton::Yes)
+			return false;
+	}
+
+	// Bring the sfv along so the copy can be verified again later on its own
+	QFile::remove(destsfv);
+	if (!QFile::copy(sfvfile, destsfv))
+	{
+		QMessageBox::critical(this, "Error", "Sfv file couldn't copied to destination!");
+		return false;
+	}
+
+	return true;
+}
+
+void QtSfvWindow::RunJob(const QString& filename)
+{
 	QFile file(filename);
 	if (!file.open(QIODevice::ReadOnly))
 	{
@@ -175,9 +314,19 @@ void QtSfvWindow::OnActionOpen()
 		if (this->ParseLine(line) == true) FileCount++;
 	}
 
+	if (!DestPath.isEmpty() && PrepareCopy(filename) != true)
+	{
+		ClearThreadPool();
+		slookup.clear();
+		slookup.shrink_to_fit();
+		label.setText("Ready for an action!");
+		return;
+	}
 
 	treeWidget->insertTopLevelItems(0, items);
 
+	CreateReportWriter(filename);
+
 	int PartsPerThread = FileCount / ThreadCount;
 	int remain = FileCount % ThreadCount;
 
@@ -187,6 +336,30 @@ void QtSfvWindow::OnActionOpen()
 	progressBar->setRange(0, FileCount);
 	progressBar->setValue(0);
 	progressBar->setFormat(QString("%%p - %v/%m"));
+
+	// Auto tune spawns the maximum and lets the tuner decide how many of them work
+	if (AutoTune == true)
+	{
+		tuner->list.clear();
+		for (int x = 0; x < FileCount; x++)
+		{
+			tuner->list.append(QDir::cleanPath(SfvPath + QDir::separator() + slookup[x]));
+		}
+
+		uint32_t limit = std::clamp<uint64_t>(FileCount, 1, AutoTuner::MaxThreads);
+		tuner->Begin(SfvPath, limit, ThreadCount, ChunkSize);
+
+		beginclock = perfclock.now();
+		for (int i = 0; i < limit; i++)
+		{
+			CreateAWorkerThread(i, 0, 0);
+		}
+
+		slookup.clear();
+		slookup.shrink_to_fit();
+		return;
+	}
+
 	for (int i = 0; i < ThreadCount; i++)
 	{
 		CreateAWorkerThread(i, i * PartsPerThread, PartsPerThread);
@@ -238,6 +411,25 @@ void QtSfvWindow::OnFileOpenFail(uint32_t TID, uint32_t item)
 	progressBar->setValue(progressBar->value() + 1);
 }
 
+void QtSfvWindow::OnFileReadFail(uint32_t TID, uint32_t item)
+{
+	items[item]->setText(3, "Failed to read file!");
+	progressBar->setValue(progressBar->value() + 1);
+}
+
+void QtSfvWindow::OnCopyFail(uint32_t TID, uint32_t item, uint32_t error)
+{
+	// Progress was already counted for this item, only add the copy verdict next to the source one
+	if (error == ReportCopyMismatch)
+	{
+		items[item]->setText(3, items[item]->text(3) + " (copy verification failed)");
+	}
+	else
+	{
+		items[item]->setText(3, items[item]->text(3) + " (copy failed)");
+	}
+}
+
 void QtSfvWindow::OnThreadJobDone(uint32_t TID)
 {
 	FinishedThreadCount++;
@@ -249,6 +441,16 @@ void QtSfvWindow::OnThreadJobDone(uint32_t TID)
 
 		label.setText("Job finished!");
 		timer.stop();
+		tuner->Finish();
+
+		if (report != nullptr)
+		{
+			report->Finish();
+			if (report->Dropped.load() != 0)
+			{
+				label.setText(QString("Job finished! %1 report records dropped").arg(report->Dropped.load()));
+			}
+		}
 	}
 }
 
@@ -256,6 +458,9 @@ void QtSfvWindow::OnSettingsWindowRequested()
 {
 	emit UpdateDialogSpinValue(ThreadCount);
 	emit UpdateDialogChunkValue(ChunkSize);
+	emit UpdateDialogAutoTune(AutoTune);
+	emit UpdateDialogReportFormat((int)ReportFormat);
+	emit UpdateDialogRereadCopies(RereadCopies);
 	settingsdiag->exec();
 }
 
@@ -269,9 +474,29 @@ void QtSfvWindow::OnUpdateChunkValue(uint32_t val)
 	ChunkSize = MB(val);
 }
 
+void QtSfvWindow::OnUpdateAutoTune(bool val)
+{
+	AutoTune = val;
+}
+
+void QtSfvWindow::OnUpdateReportFormat(int val)
+{
+	ReportFormat = (ReportWriter::Format)val;
+}
+
+void QtSfvWindow::OnUpdateRereadCopies(bool val)
+{
+	RereadCopies = val;
+}
+
 void QtSfvWindow::UpdateTimer()
 {
 	endclock = perfclock.now();
 	auto sectime = std::chrono::duration_cast<std::chrono::seconds>(endclock - beginclock).count();
-	label2.setText(QVariant(sectime).toString());
+	QString text = QVariant(sectime).toString();
+	if (AutoTune == true)
+	{
+		text += QString(" - %1 threads, %2 KB").arg(tuner->ActiveThreads.load()).arg(tuner->ChunkSize.load() >> 10);
+	}
+	label2.setText(text);
 }
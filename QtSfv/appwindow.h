@@ -1,5 +1,6 @@
 #include <iostream>
 #include <chrono>
+#include <algorithm>
 
 #include <QMainWindow>
 #include <QMenuBar>
@@ -18,6 +19,8 @@
 
 #include "sfvthread.h"
 #include "settingsdialog.h"
+#include "autotuner.h"
+#include "reportwriter.h"
 
 class QtSfvWindow : public QMainWindow
 {
@@ -25,22 +28,31 @@ class QtSfvWindow : public QMainWindow
 
 public slots:
 	void OnActionOpen();
+	void OnActionCopy();
 	void OnActionClose();
 
 	void OnAppendCrc(uint32_t TID, uint32_t item, uint32_t crc);
 	void OnFileOpenFail(uint32_t TID, uint32_t item);
+	void OnFileReadFail(uint32_t TID, uint32_t item);
+	void OnCopyFail(uint32_t TID, uint32_t item, uint32_t error);
 
 	void OnThreadJobDone(uint32_t TID);
 
 	void OnSettingsWindowRequested();
 	void OnUpdateThreadCountForJob(uint32_t val);
 	void OnUpdateChunkValue(uint32_t val);
+	void OnUpdateAutoTune(bool val);
+	void OnUpdateReportFormat(int val);
+	void OnUpdateRereadCopies(bool val);
 
 	void UpdateTimer();
 
 signals:
 	void UpdateDialogSpinValue(uint32_t val);
 	void UpdateDialogChunkValue(uint32_t val);
+	void UpdateDialogAutoTune(bool val);
+	void UpdateDialogReportFormat(int val);
+	void UpdateDialogRereadCopies(bool val);
 
 public:
 	QtSfvWindow();
@@ -53,11 +65,14 @@ public:
 	std::vector<SfvThread*> ThreadPool;
 
 	QString SfvPath;
+	QString DestPath;
 	QTreeWidget* treeWidget;
 	QList<QTreeWidgetItem*> items;
 	QLabel label;
 	QLabel label2;
 	SettingsDialog* settingsdiag;
+	AutoTuner* tuner;
+	ReportWriter* report;
 	QTimer timer;
 	QProgressBar* progressBar;
 
@@ -70,8 +85,14 @@ public:
 	uint32_t ThreadCount;
 	uint32_t FinishedThreadCount;
 	uint32_t ChunkSize;
+	bool AutoTune;
+	bool RereadCopies;
+	ReportWriter::Format ReportFormat;
 
 	void CreateAWorkerThread(uint32_t ThreadID, uint32_t beg, uint32_t partcount);
 	void ClearThreadPool();
+	void CreateReportWriter(const QString& sfvfile);
+	void RunJob(const QString& filename);
+	bool PrepareCopy(const QString& sfvfile);
 
 };
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "autotuner.h"
+
+#include <algorithm>
+
+#include <QSettings>
+#include <QStorageInfo>
+
+// Sampling period of the hill climber and the minimum gain for a step to be kept
+#define SAMPLE_INTERVAL_MS 1500
+#define GAIN_THRESHOLD 1.05
+
+AutoTuner::AutoTuner(QObject* parent) : QObject(parent)
+{
+	NextItem = 0;
+	ActiveThreads = 1;
+	ChunkSize = MinChunkSize;
+	BytesRead = 0;
+	ThreadLimit = 1;
+
+	connect(&timer, &QTimer::timeout, this, &AutoTuner::OnSample);
+}
+
+void AutoTuner::Begin(const QString& path, uint32_t limit, uint32_t threads, uint32_t chunk)
+{
+	MountPoint = QStorageInfo(path).rootPath();
+	ThreadLimit = std::clamp<uint32_t>(limit, 1, MaxThreads);
+
+	NextItem = 0;
+	BytesRead = 0;
+	ActiveThreads = threads;
+	ChunkSize = chunk;
+	Load();
+
+	ActiveThreads = std::clamp<uint32_t>(ActiveThreads, 1, ThreadLimit);
+	ChunkSize = std::clamp<uint32_t>(ChunkSize, MinChunkSize, std::min<uint64_t>(MaxChunkSize, MaxBufferBudget / ActiveThreads));
+
+	knob = Knob::Threads;
+	direction = 1;
+	misses = 0;
+	probing = false;
+	baseline = 0;
+	samples = 0;
+	lastbytes = 0;
+	lastsample = std::chrono::steady_clock::now();
+
+	timer.start(SAMPLE_INTERVAL_MS);
+}
+
+void AutoTuner::Finish()
+{
+	if (!timer.isActive())
+		return;
+
+	timer.stop();
+
+	// A half finished probe would persist an unproven value, roll it back
+	if (probing)
+	{
+		ActiveThreads = prevThreads;
+		ChunkSize = prevChunk;
+	}
+
+	// Jobs that end before the climber had a chance to measure anything tell us nothing
+	if (samples >= 3)
+		Save();
+}
+
+bool AutoTuner::TakeItem(uint32_t& item)
+{
+	item = NextItem.fetch_add(1);
+	return item < (uint32_t)list.size();
+}
+
+bool AutoTuner::Drained()
+{
+	return NextItem.load() >= (uint32_t)list.size();
+}
+
+void AutoTuner::OnSample()
+{
+	auto now = std::chrono::steady_clock::now();
+	double elapsed = std::chrono::duration<double>(now - lastsample).count();
+	uint64_t bytes = BytesRead.load();
+	double throughput = (bytes - lastbytes) / elapsed;
+
+	lastsample = now;
+	lastbytes = bytes;
+	samples++;
+
+	// First period is dominated by thread startup and cold caches
+	if (samples == 1 || elapsed <= 0)
+		return;
+
+	if (probing == false)
+	{
+		baseline = throughput;
+		ApplyStep();
+		probing = true;
+		return;
+	}
+
+	if (throughput > baseline * GAIN_THRESHOLD)
+	{
+		// Step paid off, keep climbing in the same direction
+		baseline = throughput;
+		misses = 0;
+		ApplyStep();
+		return;
+	}
+
+	ActiveThreads = prevThreads;
+	ChunkSize = prevChunk;
+	direction = -direction;
+	probing = false;
+
+	// Both directions failed, try the other knob
+	if (++misses >= 2)
+	{
+		knob = (knob == Knob::Threads) ? Knob::Chunk : Knob::Threads;
+		misses = 0;
+	}
+}
+
+void AutoTuner::ApplyStep()
+{
+	prevThreads = ActiveThreads;
+	prevChunk = ChunkSize;
+
+	for (int attempt = 0; attempt < 4; attempt++)
+	{
+		if (knob == Knob::Threads)
+		{
+			uint32_t val = direction > 0 ? prevThreads * 2 : prevThreads / 2;
+			val = std::clamp<uint32_t>(val, 1, std::min<uint64_t>(ThreadLimit, MaxBufferBudget / prevChunk));
+			if (val != prevThreads)
+			{
+				ActiveThreads = val;
+				return;
+			}
+		}
+		else
+		{
+			uint32_t val = direction > 0 ? prevChunk * 2 : prevChunk / 2;
+			val = std::clamp<uint32_t>(val, MinChunkSize, std::min<uint64_t>(MaxChunkSize, MaxBufferBudget / prevThreads));
+			if (val != prevChunk)
+			{
+				ChunkSize = val;
+				return;
+			}
+		}
+
+		// Hit a bound, turn around and eventually switch knobs
+		direction = -direction;
+		if (attempt % 2 == 1)
+			knob = (knob == Knob::Threads) ? Knob::Chunk : Knob::Threads;
+	}
+}
+
+static QString MountKey(const QString& mount)
+{
+	// Mount points are paths, keep QSettings from treating them as nested groups
+	return QString::fromLatin1(mount.toUtf8().toPercentEncoding());
+}
+
+void AutoTuner::Load()
+{
+	QSettings settings;
+	settings.beginGroup("AutoTune");
+	settings.beginGroup(MountKey(MountPoint));
+
+	if (settings.contains("ThreadCount"))
+		ActiveThreads = settings.value("ThreadCount").toUInt();
+
+	if (settings.contains("ChunkSize"))
+		ChunkSize = settings.value("ChunkSize").toUInt();
+}
+
+void AutoTuner::Save()
+{
+	QSettings settings;
+	settings.beginGroup("AutoTune");
+	settings.beginGroup(MountKey(MountPoint));
+
+	settings.setValue("ThreadCount", ActiveThreads.load());
+	settings.setValue("ChunkSize", ChunkSize.load());
+}
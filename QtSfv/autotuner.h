@@ -0,0 +1,67 @@
+#ifndef _AUTO_TUNER
+#define _AUTO_TUNER
+
+#include <atomic>
+#include <chrono>
+
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+// Hill-climbs thread count and chunk size while a job is running.
+// Workers pull items from a shared queue so the active thread count
+// can be changed on the fly; idle workers simply park.
+class AutoTuner : public QObject
+{
+	Q_OBJECT
+
+public:
+	AutoTuner(QObject* parent = 0);
+
+	static constexpr uint32_t MaxThreads = 32;
+	static constexpr uint32_t MinChunkSize = 64 << 10;
+	static constexpr uint32_t MaxChunkSize = 64 << 20;
+
+	// Upper bound for ActiveThreads * ChunkSize, every active worker holds a chunk sized buffer
+	static constexpr uint64_t MaxBufferBudget = 256 << 20;
+
+	QStringList list;
+	QString MountPoint;
+	uint32_t ThreadLimit;
+
+	std::atomic<uint32_t> NextItem;
+	std::atomic<uint32_t> ActiveThreads;
+	std::atomic<uint32_t> ChunkSize;
+	std::atomic<uint64_t> BytesRead;
+
+	void Begin(const QString& path, uint32_t limit, uint32_t threads, uint32_t chunk);
+	void Finish();
+
+	bool TakeItem(uint32_t& item);
+	bool Drained();
+
+public slots:
+	void OnSample();
+
+private:
+	enum class Knob { Threads, Chunk };
+
+	QTimer timer;
+	std::chrono::steady_clock::time_point lastsample;
+	uint64_t lastbytes;
+	uint32_t samples;
+
+	Knob knob;
+	int direction;
+	int misses;
+	bool probing;
+	double baseline;
+	uint32_t prevThreads;
+	uint32_t prevChunk;
+
+	void ApplyStep();
+	void Load();
+	void Save();
+};
+
+#endif
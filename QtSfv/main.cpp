@@ -5,6 +5,8 @@
 int main(int argc, char* argv[])
 {
 	QApplication app(argc, argv);
+	QCoreApplication::setOrganizationName("QtSfv");
+	QCoreApplication::setApplicationName("QtSfv");
 	QtSfvWindow window;
 	window.show();
 	return app.exec();
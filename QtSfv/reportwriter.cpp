@@ -0,0 +1,294 @@
+#include "reportwriter.h"
+
+#include <QFileInfo>
+#include <QDir>
+
+// Flush to disk once this much text is buffered, or whenever the queue runs dry
+#define FLUSH_SIZE (64 << 10)
+
+ReportWriter::ReportWriter(Format format) : format(format)
+{
+	Dropped = 0;
+	done = false;
+	head = 0;
+	tail = 0;
+
+	cells = std::make_unique<Cell[]>(QueueSize);
+	for (uint64_t i = 0; i < QueueSize; i++)
+	{
+		cells[i].seq.store(i, std::memory_order_relaxed);
+	}
+}
+
+bool ReportWriter::Open(const QString& path)
+{
+	file.setFileName(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+
+	// CSV has no room for a summary row, it goes next to the report instead.
+	// Drop the one from an earlier run so a missing summary keeps meaning an unfinished report.
+	if (format == Format::Csv)
+	{
+		QFileInfo info(path);
+		summaryPath = info.absolutePath() + QDir::separator() + info.completeBaseName() + ".summary.json";
+		QFile::remove(summaryPath);
+
+		file.write("file,expected,actual,size,hash_us,status,error,copy,copy_error,copy_us\n");
+	}
+
+	return true;
+}
+
+bool ReportWriter::Push(const ReportRecord& record)
+{
+	uint64_t pos = head.load(std::memory_order_relaxed);
+	Cell* cell;
+
+	while (true)
+	{
+		cell = &cells[pos & (QueueSize - 1)];
+		uint64_t seq = cell->seq.load(std::memory_order_acquire);
+		int64_t diff = (int64_t)seq - (int64_t)pos;
+
+		if (diff == 0)
+		{
+			if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+		{
+			// Writer is behind by a full queue, never make the worker wait for it
+			Dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else
+		{
+			pos = head.load(std::memory_order_relaxed);
+		}
+	}
+
+	cell->record = record;
+	cell->seq.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+bool ReportWriter::Pop(ReportRecord& record)
+{
+	Cell* cell = &cells[tail & (QueueSize - 1)];
+	if (cell->seq.load(std::memory_order_acquire) != tail + 1)
+		return false;
+
+	record = cell->record;
+	cell->seq.store(tail + QueueSize, std::memory_order_release);
+	tail++;
+	return true;
+}
+
+void ReportWriter::Finish()
+{
+	done.store(true, std::memory_order_release);
+}
+
+void ReportWriter::run()
+{
+	QByteArray out;
+	out.reserve(FLUSH_SIZE * 2);
+	ReportRecord record;
+	uint64_t written = 0;
+
+	while (true)
+	{
+		// Producers are stopped before Finish(), so one more drain after seeing it is enough
+		bool finishing = done.load(std::memory_order_acquire);
+
+		while (Pop(record))
+		{
+			Append(out, record);
+			written++;
+			if (out.size() >= FLUSH_SIZE)
+			{
+				file.write(out);
+				out.clear();
+			}
+		}
+
+		if (!out.isEmpty())
+		{
+			file.write(out);
+			out.clear();
+			file.flush();
+		}
+
+		if (finishing)
+			break;
+
+		msleep(10);
+	}
+
+	// Always closes the report, a missing summary means the writer itself was cut short
+	if (format == Format::JsonLines)
+	{
+		file.write(Summary(written));
+		file.close();
+	}
+	else
+	{
+		file.close();
+
+		QFile summary(summaryPath);
+		if (summary.open(QIODevice::WriteOnly | QIODevice::Truncate))
+			summary.write(Summary(written));
+	}
+}
+
+QByteArray ReportWriter::Summary(uint64_t written)
+{
+	// A cancelled job or a full queue shows up as records falling short of files
+	uint64_t dropped = Dropped.load();
+	uint64_t files = names.size();
+
+	QByteArray out;
+	out += "{\"summary\":true,\"files\":";
+	out += QByteArray::number((qulonglong)files);
+	out += ",\"records\":";
+	out += QByteArray::number((qulonglong)written);
+	out += ",\"dropped\":";
+	out += QByteArray::number((qulonglong)dropped);
+	out += ",\"complete\":";
+	out += (dropped == 0 && written == files) ? "true" : "false";
+	out += "}\n";
+	return out;
+}
+
+static void AppendJsonString(QByteArray& out, const QByteArray& str)
+{
+	out += '"';
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out += '\\';
+			out += c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			out += "\\u00";
+			out += QByteArray::number((unsigned char)c, 16).rightJustified(2, '0');
+		}
+		else
+		{
+			out += c;
+		}
+	}
+	out += '"';
+}
+
+static void AppendCsvString(QByteArray& out, const QByteArray& str)
+{
+	out += '"';
+	for (char c : str)
+	{
+		if (c == '"')
+			out += '"';
+		out += c;
+	}
+	out += '"';
+}
+
+static const char* StatusText(const ReportRecord& record, uint32_t expected)
+{
+	switch (record.error)
+	{
+	case ReportOpenFailed: return "open_failed";
+	case ReportReadFailed: return "read_failed";
+	}
+	return record.crc == expected ? "ok" : "corrupted";
+}
+
+// Verdict for the destination, kept apart from the source verdict above
+static const char* CopyText(const ReportRecord& record)
+{
+	switch (record.copyerror)
+	{
+	case ReportCopyFailed: return "copy_failed";
+	case ReportCopyMismatch: return "copy_mismatch";
+	}
+	return record.error == ReportOpenFailed ? "skipped" : "ok";
+}
+
+void ReportWriter::Append(QByteArray& out, const ReportRecord& record)
+{
+	uint32_t exp = expected[record.item];
+	QByteArray expstr = QByteArray::number(exp, 16).rightJustified(8, '0');
+	QByteArray actstr = QByteArray::number(record.crc, 16).rightJustified(8, '0');
+	bool hasCrc = record.error != ReportOpenFailed && record.error != ReportReadFailed;
+
+	if (format == Format::JsonLines)
+	{
+		out += "{\"file\":";
+		AppendJsonString(out, names[record.item]);
+		out += ",\"expected\":\"";
+		out += expstr;
+		out += "\",\"actual\":";
+		if (hasCrc)
+		{
+			out += '"';
+			out += actstr;
+			out += '"';
+		}
+		else
+		{
+			out += "null";
+		}
+		out += ",\"size\":";
+		out += QByteArray::number((qulonglong)record.size);
+		out += ",\"hash_us\":";
+		out += QByteArray::number((qulonglong)record.hashtime);
+		out += ",\"status\":\"";
+		out += StatusText(record, exp);
+		out += "\",\"error\":";
+		out += QByteArray::number(record.error);
+		if (copymode)
+		{
+			out += ",\"copy\":\"";
+			out += CopyText(record);
+			out += "\",\"copy_error\":";
+			out += QByteArray::number(record.copyerror);
+			out += ",\"copy_us\":";
+			out += QByteArray::number((qulonglong)record.copytime);
+		}
+		out += "}\n";
+	}
+	else
+	{
+		AppendCsvString(out, names[record.item]);
+		out += ',';
+		out += expstr;
+		out += ',';
+		if (hasCrc)
+			out += actstr;
+		out += ',';
+		out += QByteArray::number((qulonglong)record.size);
+		out += ',';
+		out += QByteArray::number((qulonglong)record.hashtime);
+		out += ',';
+		out += StatusText(record, exp);
+		out += ',';
+		out += QByteArray::number(record.error);
+		out += ',';
+		if (copymode)
+		{
+			out += CopyText(record);
+			out += ',';
+			out += QByteArray::number(record.copyerror);
+			out += ',';
+			out += QByteArray::number((qulonglong)record.copytime);
+		}
+		else
+		{
+			out += ",,";
+		}
+		out += '\n';
+	}
+}
@@ -0,0 +1,81 @@
+#ifndef _REPORT_WRITER
+#define _REPORT_WRITER
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QThread>
+#include <QFile>
+#include <QByteArray>
+#include <QList>
+
+enum ReportError : uint32_t
+{
+	ReportNoError = 0,
+	ReportOpenFailed = 1,
+	ReportReadFailed = 2,
+	ReportCopyFailed = 3,
+	ReportCopyMismatch = 4,
+};
+
+// Kept small and trivially copyable, names and expected CRCs are looked up by item on the writer side
+struct ReportRecord
+{
+	uint32_t item;
+	uint32_t crc;
+	uint64_t size;
+	uint64_t hashtime;
+	uint64_t copytime;
+	uint32_t error;
+	uint32_t copyerror;
+};
+
+// Streams per file results to disk from its own thread.
+// Workers hand records over through a bounded lock-free queue; when it is
+// full the record is dropped and counted instead of stalling the worker.
+class ReportWriter : public QThread
+{
+	Q_OBJECT
+public:
+	enum class Format { None, JsonLines, Csv };
+
+	static constexpr uint64_t QueueSize = 1 << 16;
+
+	ReportWriter(Format format);
+
+	QList<QByteArray> names;
+	std::vector<uint32_t> expected;
+	bool copymode = false;
+
+	std::atomic<uint64_t> Dropped;
+
+	bool Open(const QString& path);
+	bool Push(const ReportRecord& record);
+	void Finish();
+
+	void run();
+
+private:
+	struct Cell
+	{
+		std::atomic<uint64_t> seq;
+		ReportRecord record;
+	};
+
+	Format format;
+	QFile file;
+	QString summaryPath;
+	std::unique_ptr<Cell[]> cells;
+	std::atomic<bool> done;
+
+	// Producers and the consumer hammer different ends, keep them on separate cache lines
+	alignas(64) std::atomic<uint64_t> head;
+	alignas(64) uint64_t tail;
+
+	bool Pop(ReportRecord& record);
+	QByteArray Summary(uint64_t written);
+	void Append(QByteArray& out, const ReportRecord& record);
+};
+
+#endif
@@ -22,6 +22,20 @@ SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent)
 	spinbox2 = new QSpinBox();
 	spinbox2->setMinimum(0);
 
+	autoTuneBox = new QCheckBox();
+	autoTuneBox->setText("Auto tune");
+	autoTuneBox->setToolTip("Measures throughput while a job runs and adjusts thread count and chunk size on the fly.\nTuned values are remembered for every mount point.");
+
+	rereadBox = new QCheckBox();
+	rereadBox->setText("Re-read copied files");
+	rereadBox->setToolTip("Copy and verify reads every copied file back from the destination, bypassing the cache where possible.\nCatches bad writes at the cost of reading the data a second time.");
+
+	hbox3 = new QHBoxLayout();
+	label3 = new QLabel();
+	label3->setText("Report format");
+	label3->setToolTip("Streams a result record for every file next to the sfv file while the job runs.");
+	reportCombo = new QComboBox();
+	reportCombo->addItems({ "None", "JSON Lines", "CSV" });
 
 	hbox->addWidget(label);
 	hbox->addWidget(threadSpinbox);
@@ -29,6 +43,11 @@ SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent)
 	hbox2->addWidget(spinbox2);
 	vbox->addLayout(hbox);
 	vbox->addLayout(hbox2);
+	hbox3->addWidget(label3);
+	hbox3->addWidget(reportCombo);
+	vbox->addWidget(autoTuneBox);
+	vbox->addWidget(rereadBox);
+	vbox->addLayout(hbox3);
 
 
 	vbox->addStretch(1);
@@ -40,6 +59,12 @@ SettingsDialog::SettingsDialog(QWidget* parent) : QDialog(parent)
 
 	connect(buttonbox, &QDialogButtonBox::rejected, this, [&] { this->close(); });
 	connect(buttonbox, &QDialogButtonBox::accepted, this, &SettingsDialog::OnActionSaveSettings);
+
+	// Manual values only seed the tuner, keep them out of the way while it is on
+	connect(autoTuneBox, &QCheckBox::toggled, this, [&](bool checked) {
+		threadSpinbox->setEnabled(!checked);
+		spinbox2->setEnabled(!checked);
+	});
 }
 
 
@@ -53,6 +78,9 @@ void SettingsDialog::OnActionSaveSettings()
 {
 	emit UpdateThreadCountForJob(threadSpinbox->value());
 	emit UpdateChunkSize(spinbox2->value());
+	emit UpdateAutoTune(autoTuneBox->isChecked());
+	emit UpdateReportFormat(reportCombo->currentIndex());
+	emit UpdateRereadCopies(rereadBox->isChecked());
 	this->close();
 }
 
@@ -60,3 +88,18 @@ void SettingsDialog::OnUpdateChunkValue(uint32_t val)
 {
 	spinbox2->setValue(B2MB(val));
 }
+
+void SettingsDialog::OnUpdateAutoTune(bool val)
+{
+	autoTuneBox->setChecked(val);
+}
+
+void SettingsDialog::OnUpdateReportFormat(int val)
+{
+	reportCombo->setCurrentIndex(val);
+}
+
+void SettingsDialog::OnUpdateRereadCopies(bool val)
+{
+	rereadBox->setChecked(val);
+}
@@ -9,6 +9,8 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QDialogButtonBox>
+#include <QCheckBox>
+#include <QComboBox>
 
 class SettingsDialog : public QDialog
 {
@@ -28,14 +30,27 @@ public:
 	QLabel* label2;
 	QSpinBox* spinbox2;
 
+	QCheckBox* autoTuneBox;
+	QCheckBox* rereadBox;
+
+	QHBoxLayout* hbox3;
+	QLabel* label3;
+	QComboBox* reportCombo;
+
 public slots:
 	void OnUpdateSpinValue(uint32_t val);
 	void OnActionSaveSettings();
 	void OnUpdateChunkValue(uint32_t val);
+	void OnUpdateAutoTune(bool val);
+	void OnUpdateReportFormat(int val);
+	void OnUpdateRereadCopies(bool val);
 
 signals:
 	void UpdateThreadCountForJob(uint32_t val);
 	void UpdateChunkSize(uint32_t val);
+	void UpdateAutoTune(bool val);
+	void UpdateReportFormat(int val);
+	void UpdateRereadCopies(bool val);
 };
 
 #endif
\ No newline at end of file
@@ -1,6 +1,19 @@
 #include "sfvthread.h"
 
+#include <chrono>
+#include <cstdlib>
 #include <QFile>
+#include <QDir>
+#include <QFileInfo>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// O_DIRECT wants buffer address, length and offset aligned to the logical block size
+#define DIRECT_ALIGN 4096
 
 #define CheckForInterrupt if (this->isInterruptionRequested()) return
 
@@ -8,70 +21,336 @@
 
 void SfvThread::run()
 {
-	uint32_t crc = 0;
-	uint64_t filesize;
-	uint64_t counter;
-	QByteArray buffer;
+	if (tuner != nullptr)
+	{
+		RunTuned();
+	}
+	else
+	{
+		RunList();
+	}
 
+	CheckForInterrupt;
+	emit AcJobDone(TID);
+}
+
+void SfvThread::RunList()
+{
 	uint32_t ic = 0;
 	for (auto iter : list)
 	{
 		CheckForInterrupt;
 
-		QFile file(iter);
-		bool bFileOpened = file.open(QIODevice::ReadOnly);
+		ProcessItem(iter, beg + ic);
+		ic++;
+	}
+}
+
+void SfvThread::RunTuned()
+{
+	uint32_t item;
 
-		if (bFileOpened != true)
+	while (true)
+	{
+		CheckForInterrupt;
+
+		// Parked by the tuner, wait until we are needed again or the job runs dry
+		if (TID >= tuner->ActiveThreads.load())
 		{
-			emit AcFileOpenFail(TID, beg + ic);
+			if (tuner->Drained())
+				return;
+
+			msleep(20);
+			continue;
 		}
 
-		filesize = file.size();
-		if (bFileOpened == true)
+		if (tuner->TakeItem(item) != true)
+			return;
+
+		ProcessItem(tuner->list.at(item), item);
+	}
+}
+
+void SfvThread::ProcessItem(const QString& path, uint32_t item)
+{
+	ReportRecord record = {};
+	record.item = item;
+
+	bool bHashed = HashFile(path, record);
+
+	CheckForInterrupt;
+
+	if (bHashed != true)
+	{
+		if (record.error == ReportReadFailed)
 		{
-			if (filesize < this->ChunkSize)
-			{
-				CheckForInterrupt;
+			emit AcFileReadFail(TID, item);
+		}
+		else
+		{
+			emit AcFileOpenFail(TID, item);
+		}
+	}
+	else
+	{
+		emit AcAppendCRC(TID, item, record.crc);
+	}
+
+	if (record.copyerror != ReportNoError)
+	{
+		emit AcCopyFail(TID, item, record.copyerror);
+	}
+
+	if (report != nullptr)
+	{
+		report->Push(record);
+	}
+}
+
+QString SfvThread::CopyTarget(const QString& sourceRoot, const QString& destRoot, const QString& path)
+{
+	// Sfv entries like "../x" must never pull the copy out of the chosen directory
+	QString rel = QDir(sourceRoot).relativeFilePath(path);
+	if (rel.isEmpty() || QDir::isAbsolutePath(rel) || rel == ".." || rel.startsWith("../"))
+		return QString();
+
+	QString prefix = destRoot.endsWith('/') ? destRoot : destRoot + '/';
+	QString target = QDir::cleanPath(prefix + rel);
+	if (!target.startsWith(prefix))
+		return QString();
+
+	return target;
+}
+
+static bool IsUnder(const QString& root, const QString& path)
+{
+	QString prefix = root.endsWith('/') ? root : root + '/';
+	return path == root || path.startsWith(prefix);
+}
+
+bool SfvThread::OpenDestination(QFile& dest, const QString& path)
+{
+	QString target = CopyTarget(SourceRoot, DestRoot, path);
+	if (target.isEmpty())
+		return false;
+
+	// Symlinks inside the destination could still lead elsewhere, check the real location
+	QString parent = QFileInfo(target).absolutePath();
+	QString existing = parent;
+	while (!QFileInfo::exists(existing))
+		existing = QFileInfo(existing).absolutePath();
+
+	if (!IsUnder(DestRoot, QFileInfo(existing).canonicalFilePath()))
+		return false;
+
+	QDir().mkpath(parent);
+	if (!IsUnder(DestRoot, QFileInfo(parent).canonicalFilePath()))
+		return false;
+
+	// Truncating the source itself would lose it before it is read
+	QFileInfo targetInfo(target);
+	if (targetInfo.exists() && targetInfo.canonicalFilePath() == QFileInfo(path).canonicalFilePath())
+		return false;
+
+	dest.setFileName(target);
+	return dest.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+static uint64_t Micros(std::chrono::steady_clock::time_point begin)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+bool SfvThread::HashFile(const QString& path, ReportRecord& record)
+{
+	QByteArray buffer;
 
-				buffer = file.readAll();
-				crc = CRC32::Calculate(buffer.constData(), buffer.size());
-				buffer.clear();
-				buffer.shrink_to_fit();
-				emit AcAppendCRC(TID, beg + ic, crc);
+	// Reading and hashing the source counts as hash time, everything done for the destination as copy time
+	auto begin = std::chrono::steady_clock::now();
 
+	QFile file(path);
+	if (file.open(QIODevice::ReadOnly) != true)
+	{
+		record.error = ReportOpenFailed;
+		record.hashtime += Micros(begin);
+		return false;
+	}
+
+	record.hashtime += Micros(begin);
+
+	// Copy mode writes the very buffer that gets hashed, so every byte is read only once
+	QFile dest;
+	bool bCopy = !DestRoot.isEmpty();
+	if (bCopy)
+	{
+		begin = std::chrono::steady_clock::now();
+		if (OpenDestination(dest, path) != true)
+		{
+			record.copyerror = ReportCopyFailed;
+			bCopy = false;
+		}
+		record.copytime += Micros(begin);
+	}
+
+	record.size = file.size();
+	uint64_t counter = record.size;
+	uint32_t crc = 0;
+	while (counter > 0)
+	{
+		if (this->isInterruptionRequested())
+		{
+			if (dest.isOpen())
+				dest.remove();
+			return false;
+		}
+
+		begin = std::chrono::steady_clock::now();
+
+		// Chunk size may be changed by the tuner between reads, follow it both ways so
+		// the tuner's memory budget holds; a small file never needs a full chunk
+		uint64_t chunk = (tuner != nullptr) ? tuner->ChunkSize.load() : this->ChunkSize;
+		if (record.size < chunk)
+			chunk = record.size;
+
+		if ((uint64_t)buffer.size() != chunk)
+		{
+			buffer.resize(chunk);
+			buffer.squeeze();
+		}
+
+		qint64 got = file.read(buffer.data(), counter < chunk ? counter : chunk);
+		if (got <= 0)
+		{
+			record.error = ReportReadFailed;
+			record.hashtime += Micros(begin);
+			break;
+		}
+
+		counter -= got;
+		crc = CRC32::Calculate(buffer.constData(), got, crc);
+		record.hashtime += Micros(begin);
+
+		if (bCopy)
+		{
+			begin = std::chrono::steady_clock::now();
+			if (dest.write(buffer.constData(), got) != got)
+			{
+				record.copyerror = ReportCopyFailed;
+				bCopy = false;
 			}
-			else
+			record.copytime += Micros(begin);
+		}
+
+		if (tuner != nullptr)
+			tuner->BytesRead += got;
+	}
+
+	record.crc = crc;
+
+	if (dest.isOpen())
+	{
+		begin = std::chrono::steady_clock::now();
+
+		// Don't leave a half written copy around looking like a good one
+		if (record.error != ReportNoError || record.copyerror != ReportNoError)
+		{
+			dest.remove();
+			if (record.copyerror == ReportNoError)
+				record.copyerror = ReportCopyFailed;
+		}
+		else
+		{
+			dest.close();
+
+			// Verification brings its own buffer, don't hold two per thread against the tuner's budget
+			buffer.clear();
+			if (RereadDest && VerifyDestination(dest.fileName(), crc) != true)
 			{
-				CheckForInterrupt;
-
-				uint64_t counter = filesize;
-				crc = 0;
-				while (counter > 0)
-				{
-					CheckForInterrupt;
-
-					if (counter > this->ChunkSize)
-					{
-						buffer = file.read(this->ChunkSize);
-						counter -= this->ChunkSize;
-						crc = CRC32::Calculate(buffer.constData(), buffer.size(), crc);
-						buffer.clear();
-						buffer.shrink_to_fit();
-					}
-					else
-					{
-						buffer = file.read(counter);
-						crc = CRC32::Calculate(buffer.constData(), buffer.size(), crc);
-						buffer.clear();
-						buffer.shrink_to_fit();
-						counter -= counter;
-					}
-				}
-				emit AcAppendCRC(TID, beg + ic, crc);
+				record.copyerror = ReportCopyMismatch;
 			}
 		}
-		ic++;
+
+		record.copytime += Micros(begin);
 	}
 
-	emit AcJobDone(TID);
+	// A partial CRC would only show up as a bogus corruption
+	return record.error != ReportReadFailed;
+}
+
+bool SfvThread::VerifyDestination(const QString& path, uint32_t expect)
+{
+	uint32_t crc = 0;
+	uint64_t chunk = (tuner != nullptr) ? tuner->ChunkSize.load() : this->ChunkSize;
+
+#ifdef Q_OS_LINUX
+	// Bypass the page cache, otherwise we would only hash what we have just written from memory.
+	// EINVAL means the filesystem refuses direct I/O (older tmpfs, some FUSE mounts), anything
+	// else is a real failure of the copy.
+	int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECT);
+	if (fd < 0 && errno != EINVAL)
+		return false;
+
+	if (fd >= 0)
+	{
+		size_t len = (chunk + DIRECT_ALIGN - 1) & ~(size_t)(DIRECT_ALIGN - 1);
+		void* mem = std::aligned_alloc(DIRECT_ALIGN, len);
+		if (mem == nullptr)
+		{
+			::close(fd);
+			return false;
+		}
+
+		ssize_t got;
+		bool bFirst = true;
+		while ((got = ::read(fd, mem, len)) > 0)
+		{
+			if (this->isInterruptionRequested())
+				break;
+
+			crc = CRC32::Calculate(mem, got, crc);
+			bFirst = false;
+		}
+		int err = errno;
+
+		std::free(mem);
+		::close(fd);
+
+		if (got == 0)
+			return crc == expect;
+
+		// Only a refused first read may fall back, a device error here is exactly what we are looking for
+		if (got > 0 || bFirst != true || err != EINVAL)
+			return false;
+
+		crc = 0;
+	}
+#endif
+
+	QFile file(path);
+	if (file.open(QIODevice::ReadOnly) != true)
+		return false;
+
+#ifdef Q_OS_LINUX
+	// No direct I/O, push the copy to the device and evict it so the read has to come from there
+	if (::fdatasync(file.handle()) != 0)
+		return false;
+	::posix_fadvise(file.handle(), 0, 0, POSIX_FADV_DONTNEED);
+#else
+	// Elsewhere this read may still be served from the cache the copy just filled
+#endif
+
+	QByteArray buffer;
+	while (!file.atEnd())
+	{
+		if (this->isInterruptionRequested())
+			return false;
+
+		buffer = file.read(chunk);
+		if (buffer.isEmpty())
+			return false;
+
+		crc = CRC32::Calculate(buffer.constData(), buffer.size(), crc);
+	}
+
+	return crc == expect;
 }
@@ -3,6 +3,8 @@
 
 #include <QThread>
 #include "crc32/CRC.h"
+#include "autotuner.h"
+#include "reportwriter.h"
 
 #define MB(x)   ((size_t) (x) << 20)
 
@@ -16,11 +18,33 @@ public:
 	QStringList list;
 	uint32_t beg;
 
+	// When set, items are pulled from the tuner instead of list/beg
+	AutoTuner* tuner = nullptr;
+	ReportWriter* report = nullptr;
+
+	// Copy mode, every file is written below DestRoot with the same path it has below SourceRoot
+	QString SourceRoot;
+	QString DestRoot;
+	bool RereadDest = false;
+
 	void run();
 
+	// Maps a source file below sourceRoot to its place below destRoot, empty if it would land outside
+	static QString CopyTarget(const QString& sourceRoot, const QString& destRoot, const QString& path);
+
+private:
+	void RunList();
+	void RunTuned();
+	void ProcessItem(const QString& path, uint32_t item);
+	bool HashFile(const QString& path, ReportRecord& record);
+	bool OpenDestination(QFile& dest, const QString& path);
+	bool VerifyDestination(const QString& path, uint32_t expect);
+
 signals:
 	void AcAppendCRC(uint32_t TID, uint32_t item, uint32_t crc);
 	void AcFileOpenFail(uint32_t TID, uint32_t item);
+	void AcFileReadFail(uint32_t TID, uint32_t item);
+	void AcCopyFail(uint32_t TID, uint32_t item, uint32_t error);
 	void AcJobDone(uint32_t TID);
 };
 